@@ -275,6 +275,8 @@ int main(int argc, char** argv) {
             command[0] = 0;
         }
 
+        // Wait for a short time so that input is still read while not spinning.
+        lstalk_wait(context, 10);
         lstalk_process_responses(context);
 
         if (pending_id != LSTALK_INVALID_SERVER_ID && server_id == LSTALK_INVALID_SERVER_ID) {
@@ -29,6 +29,7 @@ SOFTWARE.
 #define __LSTALK_H__
 
 #include <stddef.h>
+#include <stdint.h>
 
 #if LSTALK_LIB
     #if LSTALK_STATIC
@@ -74,6 +75,21 @@ struct LSTalk_Context;
 typedef int LSTalk_ServerID;
 #define LSTALK_INVALID_SERVER_ID -1
 
+/**
+ * Handle to a text document opened on a server with lstalk_text_document_did_open.
+ * Requests made with a handle use the document's URI directly instead of building
+ * it from a path. A handle is valid until the document is closed.
+ */
+typedef int LSTalk_DocumentID;
+#define LSTALK_INVALID_DOCUMENT_ID 0
+
+/**
+ * A platform handle that can be waited on. This is a file descriptor on POSIX
+ * platforms and a HANDLE on Windows.
+ */
+typedef intptr_t LSTalk_Handle;
+#define LSTALK_INVALID_HANDLE ((LSTalk_Handle)-1)
+
 /**
  * The connection status to a server.
  */
@@ -101,6 +117,88 @@ typedef enum {
     LSTALK_DEBUGFLAGS_PRINT_RESPONSES = 1 << 1,
 } LSTalk_DebugFlags;
 
+/**
+ * Flags to change how the library manages its resources.
+ */
+typedef enum {
+    LSTALK_FLAGS_NONE = 0,
+
+    /**
+     * Each message received from a server, along with the notification created
+     * from it, is allocated from a single arena. The arena's memory comes from
+     * the context's allocator in large blocks and is released all at once when
+     * the notification has been polled.
+     */
+    LSTALK_FLAGS_ARENA = 1 << 0,
+
+    /**
+     * Semantic tokens are delivered as LSTALK_NOTIFICATION_SEMANTIC_TOKENS_COMPACT
+     * notifications. The tokens are stored as arrays of indices into the server's
+     * legend, which can be retrieved with lstalk_get_semantic_tokens_legend. Delta
+     * results are delivered the same way with all of the document's tokens once
+     * the delta has been applied.
+     */
+    LSTALK_FLAGS_COMPACT_SEMANTIC_TOKENS = 1 << 1,
+
+    /**
+     * Messages are read and decoded on a background thread owned by the context.
+     * Notifications are handed to lstalk_poll_notification and requests are handed
+     * to the thread through lock-free queues. lstalk_process_responses then only
+     * frees polled notifications and removes servers that have been closed. A
+     * custom allocator must be thread safe when this flag is set.
+     */
+    LSTALK_FLAGS_THREADED = 1 << 2,
+
+    /**
+     * Requests are queued instead of being written immediately. All queued
+     * requests to a server are written together with a single write on the
+     * next call to lstalk_process_responses.
+     */
+    LSTALK_FLAGS_COALESCE_REQUESTS = 1 << 3,
+
+    /**
+     * Documents opened with lstalk_text_document_did_open are read into memory
+     * and their text is kept for as long as they are open. Changes given to
+     * lstalk_text_document_did_change are applied to the kept text. Without this
+     * flag, the file is memory mapped and escaped while it is written to the
+     * server, and only the document's URI, version, and a hash of its content
+     * are kept.
+     */
+    LSTALK_FLAGS_RETAIN_TEXT_DOCUMENTS = 1 << 4,
+
+    /**
+     * A new hover or semantic tokens request cancels any pending request with
+     * the same method for the same document, as if lstalk_cancel_request was
+     * called for it.
+     */
+    LSTALK_FLAGS_LATEST_REQUEST_WINS = 1 << 5,
+
+    /**
+     * Diagnostics and document symbols are queued as the raw text of the
+     * server's message and are only parsed by lstalk_poll_notification. Queued
+     * diagnostics for a document are dropped without being parsed once newer
+     * diagnostics for the same document arrive. These notifications are always
+     * allocated with the context's allocator.
+     */
+    LSTALK_FLAGS_LAZY_NOTIFICATIONS = 1 << 6,
+
+    /**
+     * Document symbols are delivered as LSTALK_NOTIFICATION_TEXT_DOCUMENT_SYMBOLS_FLAT
+     * notifications. The symbols of a result are stored in a single array and refer
+     * to each other and to their strings by index.
+     */
+    LSTALK_FLAGS_FLAT_DOCUMENT_SYMBOLS = 1 << 7,
+
+    /**
+     * The latest diagnostics published for each document are kept by the library
+     * instead of being delivered as LSTALK_NOTIFICATION_PUBLISHDIAGNOSTICS
+     * notifications. A LSTALK_NOTIFICATION_DIAGNOSTICS_CHANGED notification is
+     * queued when a document's diagnostics change, and the diagnostics themselves
+     * are retrieved with lstalk_get_diagnostics.
+     */
+    LSTALK_FLAGS_DIAGNOSTICS_STORE = 1 << 8,
+} LSTalk_Flags;
+
 /**
  * Parameters to set when initially connecting to a language server.
  */
@@ -117,7 +215,8 @@ typedef struct LSTalk_ConnectParams {
 
     /**
      * Will seek through the PATH environment variable that fits the
-     * given URI in lstalk_connect.
+     * given URI in lstalk_connect. The path that is found is reused until
+     * the PATH changes.
      */
     int seek_path_env;
 } LSTalk_ConnectParams;
@@ -127,6 +226,26 @@ typedef struct LSTalk_ConnectParams {
  */
 struct LSTalk_Notification;
 
+/**
+ * Forward declaraction with the defintion defined below the API.
+ */
+struct LSTalk_NotificationFilter;
+
+/**
+ * Forward declaraction with the defintion defined below the API.
+ */
+struct LSTalk_PublishDiagnostics;
+
+/**
+ * Forward declaraction with the defintion defined below the API.
+ */
+struct LSTalk_SemanticTokensLegend;
+
+/**
+ * Forward declaraction with the defintion defined below the API.
+ */
+struct LSTalk_TextDocumentChange;
+
 /**
  * Allow setting custom functions for handling memory allocation.
  */
@@ -197,6 +316,41 @@ LSTALK_API void lstalk_set_locale(struct LSTalk_Context* context, const char* lo
  */
 LSTALK_API void lstalk_set_debug_flags(struct LSTalk_Context* context, int flags);
 
+/**
+ * Sets flags that change how the library manages its resources. Setting or clearing
+ * LSTALK_FLAGS_THREADED starts or stops the context's background thread.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param flags - Bitwise flags set from LSTalk_Flags.
+ */
+LSTALK_API void lstalk_set_flags(struct LSTalk_Context* context, int flags);
+
+/**
+ * Sets the directory that the results of document symbol and semantic token requests
+ * are cached in. A cached result is keyed by the server's name and version and the
+ * document's URI and content, and is queued as a notification without sending the
+ * request. Only results for opened documents whose content is known are cached. The
+ * directory must already exist. Caching is disabled by default.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param path - The directory to cache results in, or NULL to disable caching. The
+ *               string is copied.
+ */
+LSTALK_API void lstalk_set_cache_directory(struct LSTalk_Context* context, const char* path);
+
+/**
+ * Sets the number of hover and document symbol results each server keeps in memory.
+ * A kept result is keyed by the document's URI and version, the method, and the
+ * position of a hover, and is queued as a notification without sending the request.
+ * Only results for opened documents are kept, and a document's results are dropped
+ * when it is changed or closed. The least recently used results are dropped once
+ * the limit is reached. Results are not kept by default.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param size - The maximum number of results kept by each server. 0 disables the cache.
+ */
+LSTALK_API void lstalk_set_response_cache_size(struct LSTalk_Context* context, int size);
+
 /**
  * Attempts to connect to a language server at the given URI. This should be a path on the machine to an
  * executable that can be started by the library.
@@ -209,6 +363,53 @@ LSTALK_API void lstalk_set_debug_flags(struct LSTalk_Context* context, int flags
  */
 LSTALK_API LSTalk_ServerID lstalk_connect(struct LSTalk_Context* context, const char* uri, LSTalk_ConnectParams* connect_params);
 
+/**
+ * Starts several instances of the same language server behind a single server ID. Open
+ * documents are spread across the instances by the hash of their URI, and every request for
+ * a document is sent to the instance that owns it. Notifications from all instances are polled
+ * through the returned ID. The capabilities and server info are shared by the instances and
+ * the stats returned by lstalk_get_stats are totals across them. There is no single server
+ * handle for a pool, so use lstalk_get_wait_handle to wait on it. The pool is only connected
+ * once all of its instances are, and is not connected once any of them is closed.
+ *
+ * @param context - An initialized LSTalk_Context object.
+ * @param uri - File path to the language server executable.
+ * @param count - The number of instances to start.
+ *
+ * @return - Server ID representing the pool. Will be LSTALK_INVALID_SERVER_ID if any of the
+ *           instances could not be started.
+ */
+LSTALK_API LSTalk_ServerID lstalk_connect_pool(struct LSTalk_Context* context, const char* uri, LSTalk_ConnectParams* connect_params, int count);
+
+/**
+ * Connects to several language servers at once. Every server is started and sent its
+ * initialize request before any of them needs to respond, so their handshakes overlap.
+ * The initialize request is built once and shared by all of the servers.
+ *
+ * @param context - An initialized LSTalk_Context object.
+ * @param uris - File paths to the language server executables.
+ * @param count - The number of servers to connect to.
+ * @param ids - Receives the Server ID of each connection. Will be LSTALK_INVALID_SERVER_ID
+ *              for the servers that could not be started.
+ *
+ * @return - The number of servers that were started. 0 if none could be started.
+ */
+LSTALK_API int lstalk_connect_servers(struct LSTalk_Context* context, const char** uris, int count, LSTalk_ConnectParams* connect_params, LSTalk_ServerID* ids);
+
+/**
+ * Connects to a language server that is already running and listening on a socket. The
+ * address is either 'tcp://host:port' or the path of a Unix domain socket, which may be
+ * prefixed with 'unix://'. Unix domain sockets are not supported on Windows. Connecting
+ * blocks until the server accepts the connection.
+ *
+ * @param context - An initialized LSTalk_Context object.
+ * @param address - The address of the socket the server is listening on.
+ *
+ * @return - Server ID representing the connection. Will be LSTALK_INVALID_SERVER_ID if the
+ *           address is invalid or the connection was refused.
+ */
+LSTALK_API LSTalk_ServerID lstalk_connect_socket(struct LSTalk_Context* context, const char* address, LSTalk_ConnectParams* connect_params);
+
 /**
  * Retrieve the current connection status given a Server ID.
  * 
@@ -236,6 +437,68 @@ typedef struct LSTalk_ServerInfo {
     char* version;
 } LSTalk_ServerInfo;
 
+/**
+ * Latencies of the responses received for a single request method. A latency
+ * is the time from the request being sent to its response being received, in
+ * microseconds. Percentiles are estimated from a histogram and are within
+ * about 12% of the actual value.
+ */
+typedef struct LSTalk_MethodStats {
+    /**
+     * The name of the method, such as 'textDocument/hover'.
+     */
+    const char* method;
+
+    /**
+     * The number of responses received. Responses to cancelled requests are
+     * not counted.
+     */
+    int count;
+
+    unsigned int latency_p50;
+    unsigned int latency_p95;
+    unsigned int latency_p99;
+    unsigned int latency_max;
+} LSTalk_MethodStats;
+
+/**
+ * Counters for the messages exchanged with a server since it was connected or
+ * the stats were last reset.
+ */
+typedef struct LSTalk_Stats {
+    /**
+     * The number of bytes written to and read from the server.
+     */
+    unsigned long long bytes_sent;
+    unsigned long long bytes_received;
+
+    /**
+     * The number of messages written to and read from the server.
+     */
+    unsigned int messages_sent;
+    unsigned int messages_received;
+
+    /**
+     * The time spent decoding and handling the received messages, in
+     * microseconds.
+     */
+    unsigned long long decode_time;
+
+    /**
+     * The number of allocations made while handling the received messages.
+     * With LSTALK_FLAGS_ARENA, these are allocations from the arena.
+     */
+    unsigned long long allocations;
+
+    /**
+     * The stats of each method that has received a response. This is owned by
+     * the server and is valid until lstalk_get_stats is called again for the
+     * server or the server is closed.
+     */
+    LSTalk_MethodStats* methods;
+    int methods_count;
+} LSTalk_Stats;
+
 /**
  * Retrieve the server information given a LSTalker_ServerID.
  * 
@@ -246,6 +509,165 @@ typedef struct LSTalk_ServerInfo {
  */
 LSTALK_API LSTalk_ServerInfo* lstalk_get_server_info(struct LSTalk_Context* context, LSTalk_ServerID id);
 
+/**
+ * Retrieve the legend the server uses to encode semantic tokens. The token types and
+ * modifiers of a LSTalk_SemanticTokensCompact are indices into this legend.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID of the server.
+ * 
+ * @return - The server's LSTalk_SemanticTokensLegend. NULL if the server is not connected.
+ */
+LSTALK_API struct LSTalk_SemanticTokensLegend* lstalk_get_semantic_tokens_legend(struct LSTalk_Context* context, LSTalk_ServerID id);
+
+/**
+ * Retrieve the counters for the messages exchanged with a server along with the
+ * latencies of its responses. This can be used to tell a slow server apart from
+ * time spent handling its messages.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID of the server.
+ * @param stats - The LSTalk_Stats to fill in.
+ * @param reset - Set to start counting again from zero once the stats are retrieved.
+ * 
+ * @return - Non-zero if the stats were retrieved. 0 if the server is not found.
+ */
+LSTALK_API int lstalk_get_stats(struct LSTalk_Context* context, LSTalk_ServerID id, LSTalk_Stats* stats, lstalk_bool reset);
+
+/**
+ * Retrieve the latest diagnostics published for a document when LSTALK_FLAGS_DIAGNOSTICS_STORE
+ * is set. The diagnostics are a copy owned by the caller and must be freed with
+ * lstalk_free_diagnostics.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID of the server.
+ * @param path - The path of the document.
+ * @param diagnostics - The LSTalk_PublishDiagnostics to fill in.
+ * 
+ * @return - The revision of the diagnostics, which matches the revision of the last
+ *           LSTALK_NOTIFICATION_DIAGNOSTICS_CHANGED notification for the document. 0 if
+ *           no diagnostics have been published for the document.
+ */
+LSTALK_API int lstalk_get_diagnostics(struct LSTalk_Context* context, LSTalk_ServerID id, const char* path, struct LSTalk_PublishDiagnostics* diagnostics);
+
+/**
+ * Frees the diagnostics retrieved with lstalk_get_diagnostics.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param diagnostics - The LSTalk_PublishDiagnostics to free.
+ */
+LSTALK_API void lstalk_free_diagnostics(struct LSTalk_Context* context, struct LSTalk_PublishDiagnostics* diagnostics);
+
+/**
+ * The stages of exchanging messages with a server that are reported to a LSTalk_Tracer.
+ * Stages may be nested, such as the encoding of a reply while a message is dispatched.
+ */
+typedef enum {
+    /**
+     * Reading the available output of the server.
+     */
+    LSTALK_TRACE_STAGE_READ,
+
+    /**
+     * Finding the next complete message in the output.
+     */
+    LSTALK_TRACE_STAGE_FRAME,
+
+    /**
+     * Scanning the envelope of a message for its id or method.
+     */
+    LSTALK_TRACE_STAGE_DECODE,
+
+    /**
+     * Handling a decoded message, which includes finding the request it answers.
+     */
+    LSTALK_TRACE_STAGE_DISPATCH,
+
+    /**
+     * Parsing the capabilities the server responded to 'initialize' with.
+     */
+    LSTALK_TRACE_STAGE_CAPABILITIES,
+
+    /**
+     * Reading the result or params of a message into a notification.
+     */
+    LSTALK_TRACE_STAGE_NOTIFICATION,
+
+    /**
+     * Encoding and framing a request that is queued to be written.
+     */
+    LSTALK_TRACE_STAGE_ENCODE,
+
+    /**
+     * Writing the queued requests to the server.
+     */
+    LSTALK_TRACE_STAGE_WRITE,
+
+    LSTALK_TRACE_STAGE_COUNT,
+} LSTalk_TraceStage;
+
+/**
+ * Callbacks that are told when each LSTalk_TraceStage begins and ends. These are called
+ * on the thread that handles messages, which is the background thread when
+ * LSTALK_FLAGS_THREADED is set. Any of the callbacks may be NULL.
+ */
+typedef struct LSTalk_Tracer {
+    void (*on_begin)(LSTalk_TraceStage stage, LSTalk_ServerID server, void* user_data);
+    void (*on_end)(LSTalk_TraceStage stage, LSTalk_ServerID server, void* user_data);
+
+    /**
+     * Called for each allocation made through the context's allocator during a stage.
+     * The allocation belongs to the innermost stage. The callback must not call into
+     * the library.
+     */
+    void (*on_allocate)(LSTalk_TraceStage stage, LSTalk_ServerID server, size_t size, void* user_data);
+
+    void* user_data;
+} LSTalk_Tracer;
+
+/**
+ * Sets the callbacks that the stages of exchanging messages are reported to. This replaces
+ * any Chrome trace started with lstalk_start_chrome_trace. Tracing is disabled by default
+ * and costs a single check per stage and allocation while disabled. Tracing is compiled out
+ * if the library is built with LSTALK_TRACING defined as 0.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param tracer - The callbacks to report to, or NULL to disable tracing. The struct is copied.
+ * 
+ * @return - Non-zero if the tracer was set. 0 if tracing is compiled out.
+ */
+LSTALK_API int lstalk_set_tracer(struct LSTalk_Context* context, const LSTalk_Tracer* tracer);
+
+/**
+ * Starts writing the stages of exchanging messages to a file in the Chrome trace event
+ * format, which can be opened with chrome://tracing or Perfetto. The bytes allocated in
+ * each stage are written as counters. This replaces any tracer set with lstalk_set_tracer.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param path - The path of the file to write. An existing file is overwritten.
+ * 
+ * @return - Non-zero if the trace was started. 0 if the file could not be opened or tracing
+ *           is compiled out.
+ */
+LSTALK_API int lstalk_start_chrome_trace(struct LSTalk_Context* context, const char* path);
+
+/**
+ * Finishes the trace started with lstalk_start_chrome_trace and closes its file. The trace
+ * is also finished by lstalk_shutdown.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ */
+LSTALK_API void lstalk_stop_chrome_trace(struct LSTalk_Context* context);
+
+/**
+ * Retrieve the name of a stage, such as 'read'.
+ * 
+ * @param stage - The LSTalk_TraceStage to name.
+ * 
+ * @return - The name of the stage. An empty string if the stage is not valid.
+ */
+LSTALK_API const char* lstalk_trace_stage_name(LSTalk_TraceStage stage);
+
 /**
  * Requests to close a connection to a connected language server given the LSTalk_ServerID.
  * 
@@ -265,6 +687,47 @@ LSTALK_API int lstalk_close(struct LSTalk_Context* context, LSTalk_ServerID id);
  */
 LSTALK_API int lstalk_process_responses(struct LSTalk_Context* context);
 
+/**
+ * Blocks until any connected server has sent data or the timeout elapses. This
+ * should be followed by a call to lstalk_process_responses. If no servers are
+ * connected, this waits for the whole timeout. With LSTALK_FLAGS_THREADED set,
+ * this instead waits until a notification is ready to be polled.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param timeout_ms - The maximum time to wait in milliseconds. A negative value waits indefinitely.
+ * 
+ * @return - The number of servers with data ready to be processed. 0 if the timeout elapsed.
+ */
+LSTALK_API int lstalk_wait(struct LSTalk_Context* context, int timeout_ms);
+
+/**
+ * Retrieves a single handle that becomes readable when any connected server has sent
+ * data. This is an epoll file descriptor on Linux and a kqueue file descriptor on Apple
+ * platforms, which can be added to an application's own event loop. The handle is owned
+ * by the context. This is not portable: Windows has no single handle to wait on, so use
+ * lstalk_wait or the handles from lstalk_get_server_handle there instead.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * 
+ * @return - The wait handle. LSTALK_INVALID_HANDLE on platforms without one, such as Windows,
+ *            or while LSTALK_FLAGS_THREADED is set.
+ */
+LSTALK_API LSTalk_Handle lstalk_get_wait_handle(struct LSTalk_Context* context);
+
+/**
+ * Retrieves the handle the server's output is read from. This can be used to wait on
+ * individual servers with an application's own event loop. The handle is owned by the
+ * context and is closed when the server is closed. This is a file descriptor on POSIX
+ * platforms and an event to wait on with WaitForMultipleObjects on Windows.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID of the server.
+ * 
+ * @return - The server's read handle. LSTALK_INVALID_HANDLE if the server does not exist or
+ *           is a pool started with lstalk_connect_pool.
+ */
+LSTALK_API LSTalk_Handle lstalk_get_server_handle(struct LSTalk_Context* context, LSTalk_ServerID id);
+
 /**
  * Polls for any notifications received from the given server. The context will hol any
  * memory allocated for the notification. Once the notification has been polled, the
@@ -279,6 +742,30 @@ LSTALK_API int lstalk_process_responses(struct LSTalk_Context* context);
  */
 LSTALK_API int lstalk_poll_notification(struct LSTalk_Context* context, LSTalk_ServerID id, struct LSTalk_Notification* notification);
 
+/**
+ * Moves up to 'max' notifications received from the given server into the given array.
+ * Only notifications that pass the filter are returned. Any others are kept in the order
+ * they were received for later polls. The memory for the notifications is held by the
+ * context the same way as with lstalk_poll_notification.
+ *
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The server connection to poll.
+ * @param filter - The notifications to return. NULL returns all notifications.
+ * @param notifications - An array that can hold at least 'max' notifications.
+ * @param max - The maximum number of notifications to return.
+ *
+ * @return - The number of notifications written to the array. 0 if none were available.
+ */
+LSTALK_API int lstalk_drain_notifications(struct LSTalk_Context* context, LSTalk_ServerID id, const struct LSTalk_NotificationFilter* filter, struct LSTalk_Notification* notifications, int max);
+
+/**
+ * Frees all notifications returned by lstalk_poll_notification and lstalk_drain_notifications.
+ * These are otherwise freed by the next lstalk_process_responses call.
+ *
+ * @param context - An initialized LSTalk_Context object.
+ */
+LSTALK_API void lstalk_release_notifications(struct LSTalk_Context* context);
+
 /**
  * A notification that should be used by the client to modify the trace setting of the server.
  * 
@@ -301,11 +788,25 @@ LSTALK_API int lstalk_set_trace(struct LSTalk_Context* context, LSTalk_ServerID
  */
 LSTALK_API int lstalk_set_trace_from_string(struct LSTalk_Context* context, LSTalk_ServerID id, const char* trace);
 
+/**
+ * Asks the server to cancel a pending request. The response to the request is
+ * dropped without being read when it arrives, and no notification is made for it.
+ * Nothing is sent if the response has already been received.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID connection the request was sent on.
+ * @param request_id - The id returned by the function that made the request.
+ * 
+ * @return - Non-zero if the cancellation was queued. 0 if it failed.
+ */
+LSTALK_API int lstalk_cancel_request(struct LSTalk_Context* context, LSTalk_ServerID id, int request_id);
+
 /**
  * The document open notification is sent from the client to the server to
  * signal newly opened text documents. The library will attempt to open the
  * file to send the contents to the server. The contents will be properly
- * escaped to fit the JSON rpc format.
+ * escaped to fit the JSON rpc format. The file is memory mapped and streamed
+ * to the server unless LSTALK_FLAGS_RETAIN_TEXT_DOCUMENTS is set.
  * 
  * @param context - An initialized LSTalk_Context object.
  * @param id - The LSTalk_ServerID connection to open the document on.
@@ -315,6 +816,53 @@ LSTALK_API int lstalk_set_trace_from_string(struct LSTalk_Context* context, LSTa
  */
 LSTALK_API int lstalk_text_document_did_open(struct LSTalk_Context* context, LSTalk_ServerID id, const char* path);
 
+/**
+ * Retrieves the handle of a document opened with lstalk_text_document_did_open.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID connection the document is opened on.
+ * @param path - The absolute path to the file that is opened on the client.
+ * 
+ * @return - The document's handle. LSTALK_INVALID_DOCUMENT_ID if the document is not open.
+ */
+LSTALK_API LSTalk_DocumentID lstalk_text_document_get_id(struct LSTalk_Context* context, LSTalk_ServerID id, const char* path);
+
+/**
+ * The document change notification is sent from the client to the server to signal
+ * changes to a text document opened with lstalk_text_document_did_open. The changes
+ * are applied in order and sent in a single notification. The ranged changes are sent
+ * if the server supports incremental changes, otherwise the document's whole content
+ * is sent. The document's version is incremented for each call. If the document's
+ * text was not retained (see LSTALK_FLAGS_RETAIN_TEXT_DOCUMENTS) and the server only
+ * accepts whole contents, the text of the last change is sent as the whole content.
+ * If that text is NULL, the content is read from the file instead, which must then
+ * already contain the changes.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID connection the document is opened on.
+ * @param path - The absolute path to the file that is opened on the client.
+ * @param changes - The list of changes made to the document.
+ * @param changes_count - The number of elements in 'changes'.
+ * 
+ * @return - Non-zero if the notification was sent. 0 if it failed or the server does not accept changes.
+ */
+LSTALK_API int lstalk_text_document_did_change(struct LSTalk_Context* context, LSTalk_ServerID id, const char* path,
+    struct LSTalk_TextDocumentChange* changes, int changes_count);
+
+/**
+ * Same as lstalk_text_document_did_change, for the document with the given handle.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID connection the document is opened on.
+ * @param document - The handle of the opened document.
+ * @param changes - The list of changes made to the document.
+ * @param changes_count - The number of elements in 'changes'.
+ * 
+ * @return - Non-zero if the notification was sent. 0 if it failed or the server does not accept changes.
+ */
+LSTALK_API int lstalk_text_document_did_change_id(struct LSTalk_Context* context, LSTalk_ServerID id, LSTalk_DocumentID document,
+    struct LSTalk_TextDocumentChange* changes, int changes_count);
+
 /**
  * The document close notification is sent from the client to the server
  * when the document got closed in the client.
@@ -327,6 +875,18 @@ LSTALK_API int lstalk_text_document_did_open(struct LSTalk_Context* context, LST
  */
 LSTALK_API int lstalk_text_document_did_close(struct LSTalk_Context* context, LSTalk_ServerID id, const char* path);
 
+/**
+ * Same as lstalk_text_document_did_close, for the document with the given handle.
+ * The handle is no longer valid afterwards.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID connection the document is opened on.
+ * @param document - The handle of the opened document.
+ * 
+ * @return - Non-zero if the request was sent. 0 if it failed or the document is not open.
+ */
+LSTALK_API int lstalk_text_document_did_close_id(struct LSTalk_Context* context, LSTalk_ServerID id, LSTalk_DocumentID document);
+
 /**
  * Retrieves all symbols for a given document.
  * 
@@ -334,10 +894,21 @@ LSTALK_API int lstalk_text_document_did_close(struct LSTalk_Context* context, LS
  * @param id - The LSTalk_ServerID connection to open the document on.
  * @param path - The absolute path to the file that is opened on the client.
  * 
- * @return - Non-zero if the request was sent. 0 if it failed.
+ * @return - The id of the request, usable with lstalk_cancel_request. 0 if it failed.
  */
 LSTALK_API int lstalk_text_document_symbol(struct LSTalk_Context* context, LSTalk_ServerID id, const char* path);
 
+/**
+ * Same as lstalk_text_document_symbol, for the document with the given handle.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID connection the document is opened on.
+ * @param document - The handle of the opened document.
+ * 
+ * @return - The id of the request, usable with lstalk_cancel_request. 0 if it failed.
+ */
+LSTALK_API int lstalk_text_document_symbol_id(struct LSTalk_Context* context, LSTalk_ServerID id, LSTalk_DocumentID document);
+
 /**
  * Retrieves semantic tokens to provide additional information for language specific symbols.
  * 
@@ -345,10 +916,43 @@ LSTALK_API int lstalk_text_document_symbol(struct LSTalk_Context* context, LSTal
  * @param id - The LSTalk_ServerID connection to open the document on.
  * @param path - The absolute path to the file that is opened on the client.
  * 
- * @return - Non-zero if the request was sent. 0 if it failed.
+ * @return - The id of the request, usable with lstalk_cancel_request. 0 if it failed.
  */
 LSTALK_API int lstalk_text_document_semantic_tokens(struct LSTalk_Context* context, LSTalk_ServerID id, const char* path);
 
+/**
+ * Retrieves the semantic tokens that changed since the last semantic tokens response for a
+ * document. The server's edits are applied to the tokens cached for the document and a
+ * LSTALK_NOTIFICATION_SEMANTIC_TOKENS_DELTA notification is sent with only the changed
+ * tokens. If no tokens are cached for the document yet, all tokens are requested instead.
+ * With LSTALK_FLAGS_COMPACT_SEMANTIC_TOKENS set, a LSTALK_NOTIFICATION_SEMANTIC_TOKENS_COMPACT
+ * notification with all of the document's tokens is sent instead.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID connection to open the document on.
+ * @param path - The absolute path to the file that is opened on the client.
+ * 
+ * @return - The id of the request, usable with lstalk_cancel_request. 0 if it failed or the server does not support deltas.
+ */
+LSTALK_API int lstalk_text_document_semantic_tokens_delta(struct LSTalk_Context* context, LSTalk_ServerID id, const char* path);
+
+/**
+ * Retrieves the semantic tokens for a range of a document, such as the visible portion of the
+ * document. The tokens are not cached and do not affect later delta requests.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID connection to open the document on.
+ * @param path - The absolute path to the file that is opened on the client.
+ * @param start_line - The first line of the range.
+ * @param start_character - The column on 'start_line' the range starts at.
+ * @param end_line - The last line of the range.
+ * @param end_character - The column on 'end_line' the range ends at.
+ * 
+ * @return - The id of the request, usable with lstalk_cancel_request. 0 if it failed or the server does not support ranges.
+ */
+LSTALK_API int lstalk_text_document_semantic_tokens_range(struct LSTalk_Context* context, LSTalk_ServerID id, const char* path,
+    unsigned int start_line, unsigned int start_character, unsigned int end_line, unsigned int end_character);
+
 /**
  * Requests hover information at a given text document position.
  * 
@@ -358,10 +962,107 @@ LSTALK_API int lstalk_text_document_semantic_tokens(struct LSTalk_Context* conte
  * @param line - The line number in the document referenced by 'path'.
  * @param character - The column number on the line referenced by 'line' in the document referenced by 'path'.
  * 
- * @return - Non-zero if the request was sent. 0 if it failed.
+ * @return - The id of the request, usable with lstalk_cancel_request. 0 if it failed.
  */
 LSTALK_API int lstalk_text_document_hover(struct LSTalk_Context* context, LSTalk_ServerID id, const char* path, unsigned int line, unsigned int character);
 
+/**
+ * Same as lstalk_text_document_hover, for the document with the given handle.
+ * 
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID connection the document is opened on.
+ * @param document - The handle of the opened document.
+ * @param line - The line number in the document.
+ * @param character - The column number on the line referenced by 'line'.
+ * 
+ * @return - The id of the request, usable with lstalk_cancel_request. 0 if it failed.
+ */
+LSTALK_API int lstalk_text_document_hover_id(struct LSTalk_Context* context, LSTalk_ServerID id, LSTalk_DocumentID document, unsigned int line, unsigned int character);
+
+/**
+ * The requests made for each file by lstalk_batch.
+ */
+typedef enum {
+    LSTALK_BATCH_DOCUMENT_SYMBOLS = 1 << 0,
+    LSTALK_BATCH_SEMANTIC_TOKENS = 1 << 1,
+} LSTalk_BatchRequests;
+
+/**
+ * Counters reported by lstalk_batch as files complete.
+ */
+typedef struct LSTalk_BatchProgress {
+    int files_total;
+    int files_completed;
+
+    /**
+     * Files that could not be opened. No requests are made for these.
+     */
+    int files_failed;
+
+    int requests_sent;
+    int requests_completed;
+    int requests_in_flight;
+    double elapsed_seconds;
+    double files_per_second;
+} LSTalk_BatchProgress;
+
+/**
+ * Describes the work done by lstalk_batch.
+ */
+typedef struct LSTalk_BatchParams {
+    const char** paths;
+    int paths_count;
+
+    /**
+     * Bitwise flags set from LSTalk_BatchRequests.
+     */
+    int requests;
+
+    /**
+     * The maximum number of requests waiting for a response. Files are opened once
+     * all of their requests fit. A single file is always allowed to be in flight.
+     */
+    int max_in_flight;
+
+    /**
+     * The batch stops if no response arrives for this long. A negative value
+     * waits forever.
+     */
+    int idle_timeout_ms;
+
+    /**
+     * Called with each result. The notification is only valid for the duration
+     * of the call.
+     */
+    void (*on_result)(const char* path, struct LSTalk_Notification* notification, void* user_data);
+
+    /**
+     * Called after each file completes or fails. May be NULL.
+     */
+    void (*on_progress)(const LSTalk_BatchProgress* progress, void* user_data);
+
+    void* user_data;
+} LSTalk_BatchParams;
+
+/**
+ * Opens each file, makes the requested requests for it, and closes it once all of its
+ * results have arrived. Files that are already open are left open. Requests for several
+ * files are kept in flight at once so that the server is not left waiting on the caller.
+ * With LSTALK_FLAGS_THREADED set, the results are read and parsed on the background
+ * thread while more requests are written. This blocks until every file has completed,
+ * the server disconnects, or the idle timeout is reached. Notifications that are not
+ * results of the batch are left to be polled.
+ *
+ * @param context - An initialized LSTalk_Context object.
+ * @param id - The LSTalk_ServerID connection to make the requests to.
+ * @param params - The files and requests to make.
+ * @param progress - Receives the final counters. May be NULL.
+ *
+ * @return - A non-zero value if every file was completed or failed to open. 0 if the
+ *           batch was stopped early.
+ */
+LSTALK_API int lstalk_batch(struct LSTalk_Context* context, LSTalk_ServerID id, LSTalk_BatchParams* params, LSTalk_BatchProgress* progress);
+
 //
 // The section below contains the definitions of interfaces used in communicating
 // with the language server.
@@ -485,6 +1186,14 @@ typedef struct LSTalk_Range {
     LSTalk_Position end;
 } LSTalk_Range;
 
+/**
+ * A change made to a text document. The text replaces the content within the range.
+ */
+typedef struct LSTalk_TextDocumentChange {
+    LSTalk_Range range;
+    char* text;
+} LSTalk_TextDocumentChange;
+
 /**
  * Represents a location inside a resource, such as a line inside a text file.
  */
@@ -628,6 +1337,28 @@ typedef struct LSTalk_PublishDiagnostics {
     int diagnostics_count;
 } LSTalk_PublishDiagnostics;
 
+/**
+ * Sent in place of the diagnostics themselves when LSTALK_FLAGS_DIAGNOSTICS_STORE is
+ * set. Only one of these is queued for a document at a time, and it describes the
+ * latest diagnostics at the time it was polled.
+ */
+typedef struct LSTalk_DiagnosticsChanged {
+    /**
+     * The URI of the document whose diagnostics changed.
+     */
+    char* uri;
+
+    /**
+     * The version number of the document the diagnostics were published for.
+     */
+    int version;
+
+    /**
+     * Incremented each time diagnostics are published for the document.
+     */
+    int revision;
+} LSTalk_DiagnosticsChanged;
+
 /**
  * Represents programming constructs like variables, classes, interfaces etc.
  * that appear in a document. Document symbols can be hierarchical and they
@@ -689,6 +1420,50 @@ typedef struct LSTalk_DocumentSymbolNotification {
     int symbols_count;
 } LSTalk_DocumentSymbolNotification;
 
+/**
+ * A document symbol stored in a LSTalk_DocumentSymbolsFlat.
+ */
+typedef struct LSTalk_DocumentSymbolFlat {
+    /**
+     * Offsets into the result's strings of the symbol's name and detail, or -1 if
+     * the symbol does not have one.
+     */
+    int name;
+    int detail;
+
+    LSTalk_SymbolKind kind;
+    int tags;
+    LSTalk_Range range;
+    LSTalk_Range selection_range;
+
+    /**
+     * Indices into the result's symbols, or -1 if there is no such symbol. Symbols
+     * with the same parent are linked through next_sibling.
+     */
+    int parent;
+    int first_child;
+    int next_sibling;
+    int children_count;
+} LSTalk_DocumentSymbolFlat;
+
+/**
+ * Response received from a document_symbol request when LSTALK_FLAGS_FLAT_DOCUMENT_SYMBOLS
+ * is set. The symbols are stored in pre-order, so the first top level symbol is at
+ * index 0 and a symbol's descendants directly follow it. The symbols and the strings
+ * share a single allocation.
+ */
+typedef struct LSTalk_DocumentSymbolsFlat {
+    char* uri;
+    LSTalk_DocumentSymbolFlat* symbols;
+    int symbols_count;
+
+    /**
+     * The null terminated names and details of all symbols.
+     */
+    char* strings;
+    int strings_size;
+} LSTalk_DocumentSymbolsFlat;
+
 /**
  * Represents a single token with the location, the type, and 0 to n modifiers.
  */
@@ -705,11 +1480,68 @@ typedef struct LSTalk_SemanticToken {
  * List of semantic tokens retrieved from a document.
  */
 typedef struct LSTalk_SemanticTokens {
+    char* uri;
     char* result_id;
     LSTalk_SemanticToken* tokens;
     int tokens_count;
 } LSTalk_SemanticTokens;
 
+/**
+ * The token types and modifiers a server uses to encode semantic tokens.
+ */
+typedef struct LSTalk_SemanticTokensLegend {
+    /**
+     * The token types a server uses.
+     */
+    char** token_types;
+    int token_types_count;
+
+    /**
+     * The token modifiers a server uses.
+     */
+    char** token_modifiers;
+    int token_modifiers_count;
+} LSTalk_SemanticTokensLegend;
+
+/**
+ * List of semantic tokens retrieved from a document, stored as one array per
+ * property. All arrays are tokens_count long and share a single allocation.
+ */
+typedef struct LSTalk_SemanticTokensCompact {
+    char* uri;
+    char* result_id;
+    int tokens_count;
+
+    /**
+     * The absolute position and length of each token.
+     */
+    unsigned int* lines;
+    unsigned int* characters;
+    unsigned int* lengths;
+
+    /**
+     * Index into the legend's token_types.
+     */
+    unsigned int* token_types;
+
+    /**
+     * Bitmask of the legend's token_modifiers. Bit n is set if the token has
+     * the modifier at index n.
+     */
+    unsigned int* token_modifiers;
+} LSTalk_SemanticTokensCompact;
+
+/**
+ * The semantic tokens that changed in a document since the previous response. The tokens at
+ * [start, start + delete_count) of the previous response are replaced by 'tokens'. Tokens
+ * outside of this span are unchanged.
+ */
+typedef struct LSTalk_SemanticTokensDelta {
+    int start;
+    int delete_count;
+    LSTalk_SemanticTokens tokens;
+} LSTalk_SemanticTokensDelta;
+
 /**
  * Contains the message and the document range of a hover request.
  */
@@ -737,6 +1569,10 @@ typedef enum {
     LSTALK_NOTIFICATION_SEMANTIC_TOKENS,
     LSTALK_NOTIFICATION_HOVER,
     LSTALK_NOTIFICATION_LOG,
+    LSTALK_NOTIFICATION_SEMANTIC_TOKENS_COMPACT,
+    LSTALK_NOTIFICATION_SEMANTIC_TOKENS_DELTA,
+    LSTALK_NOTIFICATION_TEXT_DOCUMENT_SYMBOLS_FLAT,
+    LSTALK_NOTIFICATION_DIAGNOSTICS_CHANGED,
 } LSTalk_NotificationType;
 
 /**
@@ -750,15 +1586,37 @@ typedef struct LSTalk_Notification {
         LSTalk_SemanticTokens semantic_tokens;
         LSTalk_Hover hover;
         LSTalk_Log log;
+        LSTalk_SemanticTokensCompact semantic_tokens_compact;
+        LSTalk_SemanticTokensDelta semantic_tokens_delta;
+        LSTalk_DocumentSymbolsFlat document_symbols_flat;
+        LSTalk_DiagnosticsChanged diagnostics_changed;
     } data;
 
     LSTalk_NotificationType type;
     int polled;
 } LSTalk_Notification;
 
+/**
+ * Selects the notifications returned by lstalk_drain_notifications.
+ */
+typedef struct LSTalk_NotificationFilter {
+    /**
+     * Only notifications of this type are returned. LSTALK_NOTIFICATION_NONE returns
+     * notifications of any type.
+     */
+    LSTalk_NotificationType type;
+
+    /**
+     * Only notifications for the document with this URI are returned. NULL returns
+     * notifications for any document, as well as those that are not for a document.
+     */
+    const char* uri;
+} LSTalk_NotificationFilter;
+
 #ifdef LSTALK_TESTS
 LSTALK_API void lstalk_tests(int argc, char** argv);
 LSTALK_API void lstalk_test_server(int argc, char** argv);
+LSTALK_API void lstalk_benchmarks(int argc, char** argv);
 #endif
 
 #if defined(__cplusplus)